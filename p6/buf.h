@@ -1,7 +1,17 @@
 #ifndef BUF_H
 #define BUF_H
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <map>
+#include <string>
+#include <ostream>
 #include "db.h"
+#include "repl.h"
 // define if debug output wanted
 //#define DEBUGBUF
 
@@ -10,51 +20,85 @@ struct hashBucket
 {
 	File*	file;    // pointer a file object (more on this below)
 	int	pageNo;  // page number within a file
-	int	frameNo; // frame number of page in the buffer pool
-	hashBucket* 	next;	 // next node in the hash table
+	int	frameNo; // frame number of page in the buffer pool, -1 if empty
+	unsigned int home;  // slot the entry hashes to (for deletion)
 };
 
 
-// hash table to keep track of pages in the buffer pool
+// hash table to keep track of pages in the buffer pool.
+// The table is split into partitions, each a small open-addressing
+// (linear probing) table with its own latch.  All slots are
+// allocated up front, so lookup/insert/remove never touch the heap.
+// The table itself does no locking: callers hold the partition
+// latch (see partition()) across lookup/insert/remove and whatever
+// frame state they need to change atomically with them.
 class BufHashTbl
 {
 private:
-    int HTSIZE;
-    hashBucket**  ht; // actual hash table
-    int	 hash(const File* file, const int pageNo); // returns value between 0 and HTSIZE-1
+    struct alignas(64) partLatch { std::mutex m; };
+
+    int   numParts;     // number of partitions, a power of two
+    int   partShift;    // hash bits that select the partition
+    unsigned int partSize;  // slots per partition, a power of two
+    hashBucket*  ht;    // numParts * partSize slots
+    partLatch*   parts; // one latch per partition
+
+    // mixes (file id, pageNo) into 64 bits; low bits pick the slot,
+    // high bits the partition
+    unsigned long long hash(const File* file, const int pageNo) const;
+    int partOf(unsigned long long h) const
+      { return numParts == 1 ? 0 : (int)(h >> partShift); }
+    hashBucket* table(unsigned long long h) const
+      { return &ht[partOf(h) * partSize]; }
 
 public:
-    BufHashTbl(const int htSize);  // constructor
+    BufHashTbl(const int numBufs);  // constructor, sized for numBufs pages
     ~BufHashTbl(); // destructor
-	
+
+    // latch protecting the partition that (file,pageNo) hashes to
+    std::mutex & partition(const File* file, const int pageNo);
+
     // insert entry into hash table mapping (file,pageNo) to frameNo;
     // returns 0 if OK, HASHTBLERROR if an error occurred
   Status insert(const File* file, const int pageNo, const int frameNo);
 
     // Check if (file,pageNo) is currently in the buffer pool (ie. in
-    // the hash table).  If so, return corresponding frameNo. else return 
+    // the hash table).  If so, return corresponding frameNo. else return
     // HASHNOTFOUND
   Status lookup(const File* file, const int pageNo, int & frameNo);
 
     // delete entry (file,pageNo) from hash table. REturn OK if page was
     // found.  Else return HASHTBLERROR
-  Status remove(const File* file, const int pageNo);  
+  Status remove(const File* file, const int pageNo);
+
+    // number of slots a lookup of (file,pageNo) examines
+  int probeLength(const File* file, const int pageNo);
 };
 
 
-class BufMgr;  //forward declaration of BufMgr class 
+class BufMgr;  //forward declaration of BufMgr class
 
-// class for maintaining information about buffer pool frames
+// class for maintaining information about buffer pool frames.
+// pinCnt and dirty are touched by any thread that has the page
+// pinned and are kept atomic.  file, pageNo and valid
+// only change while the frame latch is held by the thread that
+// is (re)loading or evicting the frame; busy is set for the
+// duration of that I/O so readers know to wait on the latch.
 class BufDesc {
     friend class BufMgr;
+    friend class ReplPolicy;
 private:
   File* file;   // pointer to file object
   int   pageNo; // page within file
   int	frameNo;  // frame # of frame
-  int   pinCnt; // number of times this page has been pinned
-  bool 	dirty;	  // true if dirty;  false otherwise
+  std::atomic<int>  pinCnt; // number of times this page has been pinned
+  std::atomic<bool> dirty;  // true if dirty;  false otherwise
   bool 	valid;   // true if page is valid
-  bool  refbit;	 // has this buffer frame been reference recently
+  std::atomic<bool> busy;   // frame latched for I/O or eviction
+  std::mutex latch;         // per-frame I/O latch
+  int   fileNext;   // other frames of the same file (File::firstFrame)
+  int   filePrev;
+  std::atomic<long long> lsn;  // log record of the last change (wal.h)
 
   void Clear() {  // initialize buffer frame for a new user
     	pinCnt = 0;
@@ -62,81 +106,336 @@ private:
 	pageNo = -1;
     	dirty = false;
 	valid = false;
+	lsn = 0;
   };
 
-  void Set(File* filePtr, int pageNum) { 
+  void Set(File* filePtr, int pageNum) {
       file = filePtr;
       pageNo = pageNum;
       pinCnt = 1;
       dirty = false;
       valid = true;
-      refbit = true;
+      lsn = 0;
   }
 
   BufDesc() {
       Clear();
+      busy = false;
+      fileNext = filePrev = -1;
   }
 };
 
 
+// Counts of values in power of two buckets: bucket 0 holds 0,
+// bucket b > 0 holds [2^(b-1), 2^b).  Any thread may add to it.
+class Histogram
+{
+public:
+  enum { BUCKETS = 32 };
+
+  Histogram() { clear(); }
+  void clear()
+    {
+      for (int b = 0; b < BUCKETS; b++) counts[b] = 0;
+      sum = 0;
+    }
+  void add(unsigned long v)
+    {
+      int b = 0;
+      while (v >> b && b < BUCKETS - 1) b++;
+      counts[b]++;
+      sum += v;
+    }
+
+  long count(int b) const { return counts[b]; }
+  long total() const
+    {
+      long n = 0;
+      for (int b = 0; b < BUCKETS; b++) n += counts[b];
+      return n;
+    }
+  double mean() const { long n = total(); return n ? (double)sum / n : 0; }
+  static unsigned long low(int b) { return b == 0 ? 0 : 1UL << (b - 1); }
+
+private:
+  std::atomic<long> counts[BUCKETS];
+  std::atomic<long> sum;
+};
+
+
+// accesses of one file, kept by name across opens and closes
+struct FileStats
+{
+  std::atomic<int> hits;
+  std::atomic<int> misses;
+  std::atomic<int> diskreads;
+  std::atomic<int> diskwrites;
+
+  void clear() { hits = misses = diskreads = diskwrites = 0; }
+  FileStats() { clear(); }
+};
+
+
 struct BufStats
 {
-  int accesses;    // Total number of accesses to buffer pool
-  int diskreads;   // Number of pages read from disk (including allocs)
-  int diskwrites;  // Number of pages written back to disk
+  std::atomic<int> accesses;    // Total number of accesses to buffer pool
+  std::atomic<int> hits;        // readPage calls that found the page
+  std::atomic<int> misses;      // readPage calls that had to read it
+  std::atomic<int> diskreads;   // Number of pages read from disk (including allocs)
+  std::atomic<int> diskwrites;  // Number of pages written back to disk
+  std::atomic<int> prefetched;  // pages read ahead by the I/O threads
+  std::atomic<int> mapped;      // readPage calls served from a mapped file
+  std::atomic<int> cleanEvictions;  // victims that could simply be dropped
+  std::atomic<int> dirtyEvictions;  // victims written back first
+  std::atomic<int> cleaned;     // pages written by the background writer
+  std::atomic<int> pinsHeld;    // pins taken and not yet released
+  std::atomic<int> maxPinsHeld; // high-water mark of pinsHeld
+  std::atomic<int> maxPinCnt;   // highest pin count of a single frame
+  Histogram sweep;              // frames the policy looked at per victim
+  Histogram readLatency;        // microseconds per page read
+  Histogram writeLatency;       // microseconds per page write
 
+  // pinsHeld describes the pool, not a period, and is left alone
   void clear()
     {
-      accesses = diskreads = diskwrites = 0;
+      accesses = hits = misses = diskreads = diskwrites = prefetched = 0;
+      mapped = 0;
+      cleanEvictions = dirtyEvictions = cleaned = 0;
+      maxPinsHeld = pinsHeld.load();
+      maxPinCnt = 0;
+      sweep.clear();
+      readLatency.clear();
+      writeLatency.clear();
+    }
+
+  double hitRatio() const
+    {
+      int total = hits + misses;
+      return total ? (double)hits / total : 0;
     }
-      
+
   BufStats()
     {
+      pinsHeld = 0;
       clear();
     }
 };
 
 
-class BufMgr 
+const int DEFAULTBUFS = 100;     // pool size of minirel and dbcreate
+
+
+// How a scan is going to use the pages it reads.  Large sequential
+// reads and bulk loads go through a small ring of frames private to
+// the scan, so they do not push everybody else's pages out of the
+// pool.
+enum AccessStrategy { NORMAL, BULKREAD, BULKWRITE };
+
+const int READRINGSIZE = 8;     // frames in a BULKREAD ring
+const int WRITERINGSIZE = 16;   // frames in a BULKWRITE ring
+
+const int IORUN = 32;           // most pages read ahead or flushed in one call
+
+
+// The frames a scan has used recently, and the page it put in each.
+// A frame is only reused if it still holds that page and nobody has
+// it pinned; otherwise the slot gets a fresh frame from the pool.
+class BufRing
+{
+    friend class BufMgr;
+public:
+    BufRing(const int size);
+    ~BufRing();
+
+private:
+    std::mutex latch;  // the scan and the I/O threads share the ring
+    int   size;      // number of slots
+    int   cur;       // slot to use next
+    int*  frames;    // frame of each slot, -1 if none yet
+    File** files;    // page each frame was loaded with
+    int*  pages;
+};
+
+
+// a request to read pages ahead: up to depth pages of the page
+// chain starting at pageNo
+struct PrefetchJob
+{
+    File*    file;
+    int      pageNo;
+    int      depth;
+    std::vector<int> pages;   // these pages instead of the chain
+    BufRing* ring;
+    bool     cancel;   // set to stop a job that is running
+};
+
+
+class BufMgr
 {
 private:
-  unsigned int 	 clockHand;
   int   	 numBufs;    	// Number of pages in buffer pool
   BufHashTbl*    hashTable;  	// hash table mapping (File, page) to frame
   BufDesc*	 bufTable;  	// vector of status info, 1 per page
   BufStats	 bufStats;	// buffer pool statistics
+  ReplPolicy*	 policy;	// picks frames to replace
+  size_t	 poolBytes;	// size of the bufPool mapping
+  bool		 poolHuge;	// bufPool is on explicit huge pages
+
+  // per file statistics.  Entries are never removed, so each File
+  // caches a pointer to its entry, tagged with the id of the BufMgr
+  // it belongs to.
+  int		 id;
+  std::map<std::string, FileStats> fileStats;
+  std::mutex	 statsLatch;	// protects fileStats
+  FileStats* statsOf(File* file);
+
+  // page I/O on a frame, timed and counted
+  const Status readFrame(File* file, const int PageNo, const int frame);
+  const Status writeFrame(const int frame);
+  // the same for a run of frames holding consecutive pages of a file
+  const Status readFrames(File* file, const int PageNo, const int* frames,
+                          const int n, int & numRead);
+  const Status writeFrames(const int* frames, const int n);
+  void notePin(const int cnt);     // a pin was handed out, the page
+                                   // now has cnt of them
 
-  const Status allocBuf(int & frame);   // allocate a free frame.  
-  const void releaseBuf(int frame); // return unused frame to end of list
-  void advanceClock()
+  void allocPool(const bool hugePages);
+
+  // allocate a free frame.  On success the frame is returned
+  // pinned once, latched and marked busy, and no longer in the
+  // hash table; the caller installs the new page and calls
+  // releaseBuf() to drop the latch.
+  const Status allocBuf(int & frame);
+  const Status claimBuf(int frame);  // try to evict frame (latch held)
+  const void releaseBuf(int frame);  // clear busy flag, drop frame latch
+  const Status waitBuf(int frame, File* file, const int PageNo);
+  void linkFrame(const int frame);    // frame now holds a page of its file
+  void unlinkFrame(const int frame);  // ... and no longer does
+  // flushFile: write out latched frames of consecutive pages and
+  // take them out of the pool
+  const Status flushRun(std::vector<int> & run);
+  const Status dropFlushed(const int frame);
+  // allocBuf for a ring; the slot is recorded as holding (file,PageNo)
+  const Status ringBuf(BufRing* ring, int & frame, File* file,
+                       const int PageNo);
+
+  // readPage; a prefetch leaves stats and the replacement policy
+  // alone unless it actually reads the page
+  const Status fetchPage(File* file, const int PageNo, Page*& page,
+                         BufRing* ring, const bool prefetch);
+
+  // read-ahead.  Jobs are queued by prefetch() and run by I/O
+  // threads, which read the pages through fetchPage and unpin them.
+  int prefetchDepth;
+  std::vector<std::thread> ioThreads;
+  std::vector<PrefetchJob> running;   // job of each I/O thread
+  std::vector<bool> active;           // I/O thread is running its job
+  std::deque<PrefetchJob> jobs;
+  std::mutex jobLatch;                // protects the four above
+  std::condition_variable jobReady;
+  std::condition_variable jobDone;
+  bool stopping;
+  void ioThread(const int id);
+  // frames the I/O threads hold pinned; kept to a quarter of the
+  // pool so that read-ahead never takes the frames a reader needs
+  std::atomic<int> aheadPins;
+  bool aheadPin();                    // take one if under the limit
+  // read the pages from PageNo on that are not in the pool, up to
+  // count, in one call; returns the number read
+  int  fetchRun(File* file, const int PageNo, const int count,
+                BufRing* ring);
+  // drop queued jobs and wait for running ones on file or ring
+  void cancelPrefetch(const File* file, const BufRing* ring);
+
+  // background writer.  It writes dirty, unpinned pages out ahead
+  // of the replacement policy (see ReplPolicy::upcoming), so that
+  // allocBuf finds clean victims.
+  int writerBatch;                    // frames looked at per round, 0 = off
+  std::thread writer;
+  std::mutex writerLatch;
+  std::condition_variable writerWake;
+  bool writerStop;
+  std::atomic<int> evictions;         // since the writer was last woken
+  void writerThread();
+  bool cleanBuf(const int frame);     // write frame back if dirty and idle
+
+  long long pageKey(const File* file, const int PageNo) const
   {
-	clockHand = (clockHand + 1) % numBufs;
+	return ((long long)file->fileId << 32) | (unsigned int)PageNo;
   }
 
-
 public:
   Page*	         bufPool;   // actual buffer pool
 
-  BufMgr(const int bufs);
+  // policy is one of ReplPolicy::names(); unknown names get clock.
+  // hugePages backs the pool with huge pages where possible.
+  BufMgr(const int bufs, const char* policyName = "clock",
+         const bool hugePages = false);
   ~BufMgr();
 
-  const Status readPage(File* file, const int PageNo, Page*& page);
-  const Status unPinPage(File* file, const int PageNo, const bool dirty);
-  const Status allocPage(File* file, int& PageNo, Page*& page); 
-                        // allocates a new, empty page 
+  // ring, if given, supplies the frame on a miss
+  const Status readPage(File* file, const int PageNo, Page*& page,
+                        BufRing* ring = NULL)
+  {
+	return fetchPage(file, PageNo, page, ring, false);
+  }
+  // readPage for a page that is in the pool, or mapped, and not on
+  // its way in; HASHNOTFOUND, without reading it, if not
+  const Status readResident(File* file, const int PageNo, Page*& page);
+  // page is the pointer readPage handed out.  Pages of a file mapped
+  // read-only can only be unpinned with it: without it the pin is
+  // taken to be on a frame of the pool.
+  const Status unPinPage(File* file, const int PageNo, const bool dirty,
+                         const Page* page = NULL);
+  const Status allocPage(File* file, int& PageNo, Page*& page,
+                         BufRing* ring = NULL);
+                        // allocates a new, empty page
   const Status flushFile(const File* file); // writing out all dirty pages of the file
+  // write every dirty page back, pinned or not, and keep it in the
+  // pool; for checkpoints, when nobody is changing pages
+  const Status writeAll();
+  // the page, if it is in a frame, was changed by log record lsn;
+  // the log is flushed up to there before the frame is written
+  void  noteLSN(const Page* page, const long long lsn);
   const Status disposePage(File* file, const int PageNo); // dispose of page in file
   void  printSelf();
+  void  printStats();   // hit ratio and I/O counts
+
+  const char* getPolicyName() const { return policy->name(); }
+  int   getNumBufs() const { return numBufs; }
+  bool  onHugePages() const { return poolHuge; }
+  int   residentPages(const File* file) const { return file->numFrames; }
+
+  // ring for the given strategy, NULL for NORMAL; sized to the pool
+  BufRing* newRing(const AccessStrategy strategy) const;
+  void     freeRing(BufRing* ring);  // waits for read-ahead using it
+
+  // start numThreads I/O threads reading up to depth pages ahead;
+  // depth 0 turns read-ahead off
+  void  setPrefetch(const int depth, const int numThreads = 2);
+  int   getPrefetchDepth() const { return prefetchDepth; }
+
+  // run the background writer over the next batch frames to be
+  // replaced; batch 0 stops it
+  void  setWriter(const int batch);
+  int   getWriterBatch() const { return writerBatch; }
+
+  // queue reading up to depth pages of the chain starting at
+  // PageNo; returns at once
+  void  prefetch(File* file, const int PageNo, const int depth,
+                 BufRing* ring = NULL);
+  // the same for just these pages, which need not be all of the
+  // chain (those a scan does not pass over by the zone map)
+  void  prefetchPages(File* file, const std::vector<int> & pages,
+                      BufRing* ring = NULL);
 
   const BufStats & getBufStats() const // get buffer pool usage
   {
 	return bufStats;
   }
-  const void clearBufStats() 
-  {
-	bufStats.clear();
-  }
+  const void clearBufStats();
+  const FileStats* getFileStats(const string & fileName);  // NULL if none
+  void  dumpStats(std::ostream & out);  // all statistics as one JSON object
 };
 
 #endif
-
@@ -17,11 +17,19 @@
 // schema of relation catalog:
 //   relation name : char(32)           <-- lookup key
 //   attribute count : integer(4)
+//   page layout : integer(4)
+
+
+// how the tuples of a relation are stored on its data pages
+const int ROWLAYOUT = 0;                // whole tuples in slots
+const int PAXLAYOUT = 1;                // each attribute in a minipage
+const int PACKEDLAYOUT = 2;             // minipages compressed
 
 
 typedef struct {
   char relName[MAXNAME];                // relation name
   int attrCnt;                          // number of attributes
+  int layout;                           // ROWLAYOUT, PAXLAYOUT, ...
 } RelDesc;
 
 
@@ -51,7 +59,8 @@ class RelCatalog : public HeapFile {
   // create a new relation
   const Status createRel(const string & relation, 
 		   const int attrCnt, 
-		   const attrInfo attrList[]);
+		   const attrInfo attrList[],
+		   const int layout = ROWLAYOUT);
 
   // destroy a relation
   const Status destroyRel(const string & relation);
@@ -115,7 +124,14 @@ class AttrCatalog : public HeapFile {
 extern RelCatalog  *relCat;
 extern AttrCatalog *attrCat;
 extern Error error;
-extern Status createHeapFile(const string filename);
+extern Status createHeapFile(const string filename,
+                             const int zoneCnt = 0,
+                             const ZoneAttr zones[] = NULL);
+extern Status createPaxFile(const string filename, const int attrCnt,
+                            const short attrLen[],
+                            const char attrPack[] = NULL,
+                            const int zoneCnt = 0,
+                            const ZoneAttr zones[] = NULL);
 extern Status destroyHeapFile(const string filename);
 
 #endif
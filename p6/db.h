@@ -3,8 +3,11 @@
 
 #include <sys/types.h>
 #include <functional>
+#include <mutex>
+#include <atomic>
 #include "error.h"
 #include <string.h>
+#include <vector>
 using namespace std;
 
 // define if debug output wanted
@@ -14,11 +17,41 @@ using namespace std;
 
 // forward class definition for db
 class DB;
+struct FileStats;
+
+// Alignment of buffers handed to File::readPage/writePage.  Files
+// opened for direct I/O transfer straight to and from the buffer,
+// which the kernel requires to be aligned; local page buffers are
+// declared alignas(IOALIGN), buffer pool frames are aligned to
+// their size.
+const unsigned IOALIGN = 4096;
+
+
+// structure of DB (header) page
+
+typedef struct {
+  int nextFree;                         // page # of next page on free list
+  int firstPage;                        // page # of first page in file
+  int numPages;                         // total # of pages in file
+  int version;                          // DBVERSION; 0 in older files
+  int pageSize;                         // PAGESIZE the file was created with
+  int allocPages;                       // pages of space allocated to the
+                                        // file; 0 in older files
+} DBPage;
+
+const int DBVERSION = 2;                // format of the header page
+
+// Files grow by extents: when the allocated space runs out the file
+// doubles, but by at most this many pages at a time (DB::setExtentPages).
+const int DEFAULTEXTENT = 64;
 
 // class definition for open files
 class File {
   friend class DB;
   friend class OpenFileHashTbl;
+  friend class BufHashTbl;
+  friend class BufMgr;
+  friend class LogMgr;
 
  public:
 
@@ -30,6 +63,22 @@ class File {
 		   const Page* pagePtr);      // write page to file
   const Status getFirstPage(int& pageNo) const;     // returns pageNo of first page
 
+  // count consecutive pages starting at pageNo, in as few system
+  // calls as possible.  numRead is less than count only at the end
+  // of the file.
+  const Status readPages(const int pageNo, Page* const* pages,
+                         const int count, int& numRead) const;
+  const Status writePages(const int pageNo, const Page* const* pages,
+                          const int count);
+
+  // read and write system calls made by all files so far;
+  // allocating space counts as a write
+  static std::atomic<long> readCalls;
+  static std::atomic<long> writeCalls;
+
+  bool isDirect() const { return direct; }  // opened with O_DIRECT
+  bool isMapped() const { return mapped; }  // pages read from a mapping
+
   bool operator == (const File & other) const
     {
       return fileName == other.fileName;
@@ -43,8 +92,17 @@ class File {
   static const Status create(const string &fileName);
   static const Status destroy(const string &fileName);
 
-  const Status open();
+  // direct: bypass the OS page cache if the file system allows it.
+  // mapReadOnly: the caller only reads the file; if it is the first
+  // to open it, map the file and serve its pages from the mapping
+  // until somebody opens it to write.
+  const Status open(const bool direct, const bool mapReadOnly);
+  void mapFile();
+  const Status readHeader();            // and check the page size
+  const Status writeHeader();           // if it changed
+  const Status extend();                // allocate the next extent
   const Status close();
+  const Status sync();                  // header and pages to disk
 
   const Status intread(const int pageNo,
 		 Page* pagePtr) const;        // internal file read
@@ -57,11 +115,31 @@ class File {
 
   string fileName;                    // The name of the file
   int openCnt;                        // # times file has been opened
+  bool parked;                        // closed by everybody, but kept
+                                      // open for the log (DB::closeFile)
   int unixFile;                       // unix file stream for file
+  bool direct;                        // unixFile was opened with O_DIRECT
+  int fileId;                         // unique per File object, used
+                                      // to hash buffer pool pages
+  mutable std::mutex ioLatch;         // serializes header page updates
+  DBPage header;                      // header page of the open file;
+  bool headerDirty;                   // written back on close
+  int extentPages;                    // largest extent to grow by
+  const char* map;                    // the whole file, mapped read-only
+  int mapPages;                       // pages in the mapping
+  std::atomic<int>* mapPins;          // pins on each page of the mapping
+  std::atomic<bool> mapped;           // new pins come from the mapping
+  int firstFrame;                     // buffer pool frames holding pages
+  int numFrames;                      // of the file, linked through
+  mutable std::mutex frameLatch;      // BufDesc::fileNext; see BufMgr
+  std::atomic<FileStats*> stats;      // BufMgr statistics of the file
+  std::atomic<int> statsOwner;        // id of the BufMgr they belong to
 };
 
 class BufMgr;
 extern BufMgr* bufMgr;
+class LogMgr;
+extern LogMgr* logMgr;
 
 // declarations for hash table of open files
 struct fileHashBucket
@@ -94,6 +172,9 @@ public:
 
     // returns OK if fileName was found.  Else return HASHTBLERROR
     Status erase(const string fileName);
+
+    // all files in the table
+    void getFiles(vector<File*> & files);
 };
 
 
@@ -106,20 +187,42 @@ class DB {
   const Status createFile(const string & fileName) ;  // create a new file
   const Status destroyFile(const string & fileName) ; // destroy a file, 
                                                            // release all space
-  const Status openFile(const string & fileName, File* & file);  // open a file
+  // open a file; readOnly promises that this opener will not
+  // change it (see setMapReadOnly)
+  const Status openFile(const string & fileName, File* & file,
+                        const bool readOnly = false);
   const Status closeFile(File* file);         // close a file
 
+  // With a write-ahead log (logMgr) a file that nobody has open any
+  // more stays open, so that its dirty pages can stay in the buffer
+  // pool.  A checkpoint writes the headers of all open files, syncs
+  // them and closes those files for good.  The caller has written
+  // the dirty pages.
+  const Status checkpoint();
+
+  // open files from now on with O_DIRECT, so pages are cached only
+  // in the buffer pool.  Files on file systems that refuse it are
+  // opened normally.
+  void setDirectIO(const bool on) { directIO = on; }
+  bool getDirectIO() const { return directIO; }
+
+  // map files that are only opened read-only, so the buffer pool
+  // hands out pointers into the mapping instead of copying pages
+  // into frames.  Not used with direct I/O.
+  void setMapReadOnly(const bool on) { mapReadOnly = on; }
+  bool getMapReadOnly() const { return mapReadOnly; }
+
+  // largest number of pages files grow by at a time; 1 grows them
+  // page by page
+  void setExtentPages(const int pages) { extentPages = pages > 0 ? pages : 1; }
+  int  getExtentPages() const { return extentPages; }
+
  private:
   OpenFileHashTbl   openFiles;    // list of open files
+  std::mutex latch;       // protects openFiles and open counts
+  bool directIO;          // open files with O_DIRECT
+  int extentPages;        // passed to files when they are opened
+  bool mapReadOnly;       // map files opened read-only
 };
 
-
-// structure of DB (header) page
-
-typedef struct {
-  int nextFree;                         // page # of next page on free list
-  int firstPage;                        // page # of first page in file
-  int numPages;                         // total # of pages in file
-} DBPage;
-
 #endif
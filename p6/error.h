@@ -17,7 +17,8 @@ enum Status {
 // File and DB errors
 
        BADFILEPTR, BADFILE, FILETABFULL, FILEOPEN, FILENOTOPEN,
-       UNIXERR, BADPAGEPTR, BADPAGENO, FILEEXISTS,
+       UNIXERR, BADPAGEPTR, BADPAGENO, FILEEXISTS, BADPAGESIZE,
+       READONLY, BADLOG,
 
 // BufMgr and HashTable errors
 
@@ -49,6 +50,8 @@ enum Status {
 
 // Utility errors
 
+       BADSTATSOPT,
+
 // Query errors
 
        ATTRTYPEMISMATCH, TMP_RES_EXISTS,
@@ -24,6 +24,72 @@ const unsigned MAXNAMESIZE = 50;
 enum Datatype { STRING, INTEGER, FLOAT };    // attribute data types
 enum Operator { LT, LTE, EQ, GTE, GT, NE };  // scan operators
 
+// A predicate kernel compares the attribute at attr with filter; there
+// is one for each datatype and operator.  A code kernel compares a
+// frame of reference code of a packed minipage with the filter less
+// the base.
+typedef bool (*MatchFn)(const char* attr, const char* filter,
+                        const int length);
+typedef bool (*CodeFn)(const long long code, const long long filter);
+// A batch kernel compares n integers or floats at values, one after
+// the other, leaving 1 for each that satisfies the comparison in out.
+typedef void (*BatchFn)(const char* values, const int n,
+                        const char* filter, char* out);
+
+// A predicate of a scan: a comparison of an attribute with a filter,
+// or the AND or the OR of any number of predicates, or the NOT of one.
+// Filters are not copied and must outlive the scan.
+enum PredKind { P_TERM, P_AND, P_OR, P_NOT };
+
+struct Predicate
+{
+    PredKind kind;
+    int   offset;              // P_TERM: the attribute,
+    int   length;
+    Datatype type;
+    const char* filter;        //   the value it is compared with
+    Operator op;               //   and how
+    vector<Predicate> terms;   // P_AND, P_OR, P_NOT: the operands
+};
+
+// Free space map: one byte per page of the file, the free space of
+// the page in FSMUNIT byte units, rounded down; 0 if the page is
+// full or not known.  The map is kept on pages of the file outside
+// the page chain, listed in the header page, each covering PAGESIZE
+// pages.  Pages beyond MAXFSMPAGES maps are not tracked.
+const unsigned FSMUNIT = PAGESIZE / 256;
+static_assert(FSMUNIT > 0, "the free space map needs pages of 256 bytes or more");
+const int MAXFSMPAGES = 32;
+const int FSMMAGIC = 0x46534d31;  // header has a free space map
+
+// A file of PAX pages (page.h) says so in its header, along with the
+// attribute lengths every data page is laid out for, and for packed
+// PAX pages how each attribute is to be packed.
+const int PAXFILEMAGIC = 0x50415831;
+const int PACKFILEMAGIC = 0x50414b31;
+
+// Zone map: for each data page, the smallest and the largest value
+// of each INTEGER and FLOAT attribute the file was created to
+// summarize, and the page after it in the chain, so that a scan can
+// pass over pages that cannot hold a match without reading them.
+// Entries are kept on map pages outside the page chain, indexed by
+// page number like the free space map; the header lists up to
+// MAXZONEDIRS directory pages, each listing PAGESIZE / sizeof(int)
+// map pages (half as many directories on 512 byte pages, or the
+// header would not fit).  Every change to a data page brings its
+// entry up to date; a page without an entry, beyond what the
+// directories cover, is read.  Deletes only narrow the ranges when
+// they remove a bound.
+const int MAXZONEATTRS = 8;
+const int MAXZONEDIRS = PAGESIZE >= 1024 ? 32 : 16;
+const int ZONEMAGIC = 0x5a4f4e31;  // header has a zone map
+
+struct ZoneAttr
+{
+  short		offset;		// of the attribute in the record
+  short		type;		// INTEGER or FLOAT
+};
+
 struct FileHdrPage
 {
   char		fileName[MAXNAMESIZE];   // name of file
@@ -31,8 +97,24 @@ struct FileHdrPage
   int		lastPage;	// pageNo of last data page in file
   int		pageCnt;	// number of pages
   int		recCnt;		// record count
+  int		fsmMagic;	// FSMMAGIC; anything else in older files
+  int		fsmCnt;		// pages of free space map
+  int		fsmPages[MAXFSMPAGES];	// their page numbers
+  unsigned char	fsmMax[MAXFSMPAGES];	// no entry of the map page is larger
+  int		layoutMagic;	// PAXFILEMAGIC or PACKFILEMAGIC; anything
+				// else: slotted pages
+  short		paxAttrCnt;	// PAX files: attributes of a record
+  short		paxAttrLen[MAXPAXATTRS];	// and their lengths
+  char		paxAttrPack[MAXPAXATTRS];	// packed: PACKNONE etc.
+  int		zoneMagic;	// ZONEMAGIC; anything else: no zone map
+  short		zoneAttrCnt;	// attributes summarized
+  ZoneAttr	zoneAttrs[MAXZONEATTRS];
+  int		zoneDirCnt;	// directory pages of the zone map
+  int		zoneDirs[MAXZONEDIRS];	// their page numbers
 };
 
+static_assert(sizeof(FileHdrPage) <= PAGESIZE, "header page overflows");
+
 
 // class definition of heapFile
 class HeapFile {
@@ -46,11 +128,49 @@ protected:
    int   	curPageNo;	// page number of pinned page
    bool  	curDirtyFlag;   // true if page has been updated
    RID   	curRec;         // rid of last record returned
+   BufRing*	ring;		// frames for BULKREAD/BULKWRITE, else NULL
+   bool		readOnly;	// opened to read only
+   char*	tuple;		// PAX files: records are put together here,
+				// else NULL
+   vector<int>	zoneMaps;	// zone map pages looked up so far, by
+				// index; -1 if not yet
+
+   // record the free space of a data page in the free space map
+   const Status noteFreeSpace(const int pageNo, const int freeSpace);
+   // a data page with at least needed bytes free, -1 if none known
+   const Status findFreePage(const int needed, int & pageNo);
+
+   // bring the zone map entry of a data page up to date after a
+   // change to it: ZONEINSERT widens the ranges to take in rec,
+   // ZONEDELETE narrows them if rec held a bound, ZONELINK only notes
+   // the next page; ZONEPAGE, and any change to a page without ranges
+   // yet, summarizes the whole page
+   enum ZoneChange { ZONEPAGE, ZONEINSERT, ZONEDELETE, ZONELINK };
+   const Status noteZone(const int pageNo, const Page* page,
+                         const ZoneChange change,
+                         const Record* rec = NULL);
+   // the map page holding the entry of pageNo, allocated if create
+   // and need be; -1 if there is none
+   const Status zoneMapPage(const int pageNo, const bool create,
+                            int & mapPageNo);
+
+   // changes to data pages, logged if there is a write-ahead log
+   // (wal.h); insertOn and deleteFrom keep the record count
+   const Status insertOn(const int pageNo, Page* page,
+                         const Record & rec, RID & rid);
+   const Status deleteFrom(const int pageNo, Page* page, const RID & rid);
+   const Status initPage(const int pageNo, Page* page); // empty, last
+   const Status linkPage(const int pageNo, Page* page, const int nextPageNo);
+   void logAlloc();     // the file header, after allocating or disposing
+   void logHeader();    // the header page, after changing the page chain
+   void setFsmMax(const int map, const unsigned char max);  // and log it
 
 public:
 
-  // initialize
-  HeapFile(const string & name, Status& returnStatus);
+  // initialize; readOnly files may be mapped (DB::setMapReadOnly)
+  // and cannot be changed
+  HeapFile(const string & name, Status& returnStatus,
+           const bool readOnly = false);
 
   // destructor
   ~HeapFile();
@@ -58,16 +178,51 @@ public:
   // return number of records in file
   const int getRecCnt() const;
 
-  // given a RID, read record from file, returning pointer and length
+  // return number of data pages in file
+  const int getPageCnt() const;
+
+  // given a RID, read record from file, returning pointer and length.
+  // Records of PAX files are copied; the copy lasts until the next
+  // record is read.
   const Status getRecord(const RID &rid, Record & rec);
+
+  // true if the data pages are PAX pages
+  const bool isPax() const { return tuple != NULL; }
+
+  // lay out an empty data page of this file in memory, for records to
+  // be added to with Page::insertRecord (InsertFileScan::appendPage)
+  void formatPage(const int pageNo, Page* page) const;
+
+  // how data pages are read/allocated from now on (see buf.h)
+  const Status setAccessStrategy(const AccessStrategy strategy);
 };
 
 
+// records in a batch of the query operators' scans
+const int SCANBATCH = 64;
+
+// Parallel scans: the workers share a cursor on the page chain of the
+// file and claim a morsel of MORSELPAGES pages of it at a time.
+const int MORSELPAGES = 16;
+
+struct MorselCursor
+{
+    std::mutex latch;
+    bool  started;             // nextPageNo is set
+    int   nextPageNo;          // first page of the next morsel, -1: none
+    bool  reading;             // a worker is reading the page that
+    std::condition_variable linked;  //   tells nextPageNo
+    int   aheadLeft;           // pages left before the next read-ahead
+    MorselCursor() : started(false), nextPageNo(-1), reading(false),
+                     aheadLeft(0) {}
+};
+
 class HeapFileScan : public HeapFile
 {
 public:
 
-    HeapFileScan(const string & name, Status & status);
+    HeapFileScan(const string & name, Status & status,
+                 const bool readOnly = false);
 
     // end filtered scan
     ~HeapFileScan();
@@ -76,7 +231,16 @@ public:
                            const int length,  
                            const Datatype type, 
                            const char* filter, 
-                           const Operator op);
+                           const Operator op,
+                           const AccessStrategy strategy = NORMAL);
+    // scan for records that satisfy a predicate tree, in one pass
+    const Status startScan(const Predicate & pred,
+                           const AccessStrategy strategy = NORMAL);
+
+    // take part in a parallel scan: scanNextBatch returns the records
+    // of the morsels this scan claims from cursor, until none are
+    // left.  Each worker thread has a scan of its own.
+    const Status startMorsels(MorselCursor & cursor);
 
     const Status endScan(); // terminate the scan
     const Status markScan(); // save current position of scan
@@ -85,21 +249,42 @@ public:
     // return RID of next record that satisfies the scan 
     const Status scanNext(RID& outRid);
 
+    // return up to max records that satisfy the scan, all from one
+    // page, and their RIDs; valid until the next call.  recs may be
+    // NULL if only the RIDs are wanted.
+    const Status scanNextBatch(RID rids[], Record recs[], const int max,
+                               int & cnt);
+
     // read current record, returning pointer and length
     const Status getRecord(Record & rec);
 
-    // delete current record 
+    // copy bytes [offset, offset + length) of the current record;
+    // on PAX pages this reads only the attributes in the range
+    const Status getField(const int offset, const int length, char* out);
+    // the same of a record of the last batch
+    const Status getField(const RID & rid, const int offset,
+                          const int length, char* out);
+
+    // delete current record; READONLY if opened read-only
     const Status deleteRecord();
+    // delete a record of the last batch
+    const Status deleteRecord(const RID & rid);
 
-    // marks current page of scan dirty
+    // marks current page of scan dirty; READONLY if opened read-only
     const Status markDirty();
 
+    // pages of the file the scan passed over by their zone map entries
+    const int getPagesSkipped() const { return pagesSkipped; }
+
 private:
     int   offset;            // byte offset of filter attribute
     int   length;            // length of filter attribute
     Datatype type;           // datatype of filter attribute
     const char* filter;      // comparison value of filter
     Operator op;             // comparison operator of filter
+    MatchFn matchFn;         // kernel for type and op
+    CodeFn codeFn;           // kernel for op on packed integers
+    BatchFn batchFn;         // kernel for a batch, NULL for strings
 
      // The following variables are used to preserve the state
     // of the scan when the method markScan() is invoked.
@@ -108,7 +293,91 @@ private:
     int   markedPageNo;	// page number of pinned page
     RID   markedRec;         // rid of last record returned
 
+    int   aheadLeft;         // pages left before the next read-ahead
+    vector<int> aheadPages;  // the pages of it when pruning
+
+    // On PAX pages, and for batches, the filter attribute is compared
+    // for the whole page at once; these are the results for the slots
+    // of page matchPageNo (-1: none), false for free slots
+    vector<char> matches;
+    int   matchPageNo;
+    int   matchBase;           // slot number of matches[0]
+    vector<char> dictMatches;  // for each entry of a packed minipage
+    vector<char> gathered;     // filter attribute of the records in slots
+    vector<int> slots;         //   and the index of their slots
+    vector<char> selected;     // batch kernel results
+    vector<char> batchTuples;  // PAX records of the last batch
+
+    // A predicate tree, node 0 its root, or empty.  The operands of
+    // AND and OR are evaluated in order and only for the records not
+    // yet decided, so each node counts the records it was evaluated
+    // for and those that satisfied it; after each page the operands
+    // are reordered, the AND ones by how few records pass, the OR
+    // ones by how many.
+    struct PredNode
+    {
+        PredKind kind;
+        int   offset;
+        int   length;
+        Datatype type;
+        Operator op;
+        int   zone;            // zone map attribute compared, or -1
+        const char* filter;
+        MatchFn matchFn;
+        BatchFn batchFn;
+        vector<int> terms;     // nodes of the operands
+        double tested;         // records evaluated, starting with a
+        double passed;         //   guess, and those that passed
+        vector<char> values;   // evalPred's for a page, sized by
+        vector<int> open;      //   startScan: the attribute values or
+        vector<int> place;     //   the records still open, where their
+        vector<char> sel;      //   outcomes go, and those outcomes
+    };
+    vector<PredNode> preds;
+    vector<int> predAll;       // 0, 1, ...: every record, for the root
+
+    // the pages of the morsel being scanned, claimed by claimMorsel;
+    // pages before morselPos have been scanned
+    MorselCursor* morsels;     // NULL unless in a parallel scan
+    vector<int> morselPages;
+    unsigned int morselPos;
+
+    const Status claimMorsel();
+    const Status nextMorselPage(); // FILEEOF when none are left
+
+    // Pages whose zone map entry shows they cannot hold a match are
+    // passed over: zone is the zone map attribute of the filter, or
+    // -1, and pruning says whether any comparison has one.
+    int   zone;
+    bool  pruning;
+    int   pagesSkipped;
+    int   zonePageNo;          // map page kept pinned between pages,
+    Page* zonePage;            //   -1 if none
+    int   findZone(const int offset, const Datatype type) const;
+    const bool zonePrunes(const int node, const bool negate) const;
+    const bool zoneMay(const int node, const int* entry,
+                       const bool negate) const;
+    const Status skipPages(int & pageNo); // to the next page that may match
+    // the zone map entry of the page, NULL if none; its map page
+    // stays pinned as zonePage
+    const Status zoneEntry(const int pageNo, const int*& entry);
+    // read-ahead when pruning: up to depth pages from pageNo on
+    // that skipPages would not pass over
+    const Status zonePages(int pageNo, const int depth);
+    void  prefetchFrom(const int pageNo, const int depth);
+    const Status unpinZonePage();
+
+    const Status addPred(const Predicate & pred, int & node);
+    void  orderTerms(const int node);
+    void  evalPred(const int node, const int cand[], const int n,
+                   char out[]);
+
     const bool matchRec(const Record & rec) const;
+    // does the current record satisfy the filter
+    const Status matchCur(bool & match);
+    void  matchPage();       // compare every record on the page
+    const Status nextMatch(RID& nextRid) const;
+    void  readAhead();       // prefetch pages after the current one
 };
 
 
@@ -123,6 +392,57 @@ public:
 
     // insert record into file, returning its RID
     const Status insertRecord(const Record & rec, RID& outRid); 
+
+    // add a page of recCnt records, laid out by formatPage and filled
+    // outside the buffer pool, to the end of the file
+    const Status appendPage(const Page* page, const int recCnt);
 };
 
+
+// Compacts a heap file a step at a time.  The first pass walks the
+// page chain and disposes of empty pages; the second moves the
+// records of the last pages of the chain into free space on pages
+// nearer the front and disposes of the pages it empties.  Records
+// that are moved get new RIDs.
+//
+// No page stays pinned between steps and each step leaves the chain,
+// the header and the free space map consistent, so a vacuum can be
+// stopped after any step or interleaved with other work on the
+// relation, as long as no scan of it is open while a step runs.
+
+class VacuumFileScan : public HeapFile
+{
+public:
+
+    VacuumFileScan(const string & name, Status & status);
+
+    ~VacuumFileScan();
+
+    // do the next step; FILEEOF once the file is compact
+    const Status vacuumNext();
+
+    const int getRecsMoved() const { return recsMoved; }
+    const int getPagesFreed() const { return pagesFreed; }
+
+private:
+    enum { SWEEP, COMPACT, DONE } phase;
+    int   prevPageNo;        // sweep: page before curPageNo, -1 if none
+    vector<int> chain;       // pages kept by the sweep, in chain order
+    int   front;             // compact: index of the page to fill
+    int   back;              // compact: index of the page to empty
+    int   recsMoved;
+    int   pagesFreed;
+
+    const Status sweepPage();
+    const Status compactPage();
+    // unlink page pageNo, which follows prevNo (-1: none, prev may
+    // be NULL if it is not pinned) and is followed by nextNo
+    const Status freePage(const int pageNo, const int prevNo,
+                          Page* prev, const int nextNo);
+};
+
+// recovery put rec back on page pageNo of file: widen the zone map
+// entry of the page to take it in
+const Status widenZone(File* file, const int pageNo, const Record & rec);
+
 #endif
@@ -1,6 +1,8 @@
 #ifndef PAGE_H
 #define PAGE_H
 
+#include <stddef.h>
+#include <string.h>
 #include "error.h"
 
 struct RID{
@@ -22,17 +24,96 @@ struct slot_t {
         short	length;  // equals -1 if slot is not in use
 };
 
-const unsigned PAGESIZE = 1024;
+// The page size is fixed at compile time (make PAGESIZE=n, see the
+// Makefile).  Slot offsets and lengths are shorts, so pages can be
+// at most 16K.  Files record the page size they were created with
+// and cannot be opened by a build with a different one.
+#ifndef PAGESIZE_BYTES
+#define PAGESIZE_BYTES 1024
+#endif
+
+const unsigned PAGESIZE = PAGESIZE_BYTES;
+static_assert(PAGESIZE >= 512 && PAGESIZE <= 16384
+	      && (PAGESIZE & (PAGESIZE - 1)) == 0,
+	      "PAGESIZE must be a power of two between 512 and 16384");
+
 const unsigned DPFIXED= sizeof(slot_t)+4*sizeof(short)+2*sizeof(int);
 const unsigned PAGEDATASIZE = PAGESIZE-DPFIXED+sizeof(slot_t);
 // size of the data area of a page
 
+// Page formats.  Version 1 pages keep their records compacted: every
+// delete slides the records after the hole down, and an insert
+// searches the slot array for a free slot.  Records are not aligned.
+//
+// Version 2 pages (the format of every page initialized now) reserve
+// slot 0 to tell them apart: its length is -1 and its offset is
+// PAGEV2MAGIC.  A version 1 page never looks like that, since a free
+// slot of its own has offset 0.  Free slots are kept on a list whose
+// head is in the word version 1 left unused; a free slot's length is
+// -1 - the next free slot, so -1 ends the list, and its offset is
+// where its record was (-1 if that space is gone), with the size of
+// the hole in the hole's first bytes.  A delete only frees the space;
+// an insert takes the hole of the slot it reuses if the record fits,
+// and otherwise compacts the page when the space at the end is not
+// enough.  Records start at multiples of RECALIGN bytes.
+//
+// Both formats share the slot array, so pages of either format are
+// read the same way; changes to a version 1 page keep it version 1.
+
+const int PAGEV1 = 1;
+const int PAGEV2 = 2;
+const int PAGEPAX = 3;
+const int PAGEPACKED = 4;
+const short PAGEV2MAGIC = 0x5632;
+const short PAGEPAXMAGIC = 0x5058;
+const short PAGEPACKMAGIC = 0x505a;
+
+const unsigned RECALIGN = 8;
+const unsigned MAXRECLEN = (PAGESIZE - DPFIXED - sizeof(slot_t))
+                           & ~(RECALIGN - 1);
+// largest record a page holds
+
+// PAX pages hold records of a fixed list of fixed length attributes,
+// each attribute in a minipage of its own: the values of attribute i
+// of the records in slots 1, 2, ... follow each other in minipage i.
+// Slot 0 is reserved as in version 2, with offset PAGEPAXMAGIC, and
+// there are no other slots; the page starts with a header (attribute
+// count, capacity, record count, record length, then the length and
+// minipage offset of each attribute) and a bitmap of the slots in
+// use, followed by the minipages.  Records have to be copied together
+// to be read whole; getField and getColumn read attributes in place.
+
+const int MAXPAXATTRS = 40;     // attributes of a PAX page
+
+// Packed PAX pages keep minipages encoded.  Each attribute is packed
+// as asked for when the page was initialized, if that pays off:
+// 4 byte integers as codes of a few bits added to a base value
+// (frame of reference), other attributes as codes into a dictionary
+// of the distinct values on the page.  Codes are bit packed.  An
+// insert whose values fit the encodings of the page appends codes;
+// otherwise the page is packed anew, for the records on it and the
+// new one, if they all fit.  Deleted records are dropped from the
+// encodings then; the slots of the others stay the same.
+
+const char PACKNONE = 0;        // attribute stored as is
+const char PACKFOR = 1;         // frame of reference, 4 byte integers
+const char PACKDICT = 2;        // dictionary
+
+// an attribute's minipage, as getColumn finds it
+struct PaxColumn
+{
+  int		pack;		// PACKNONE: values, else codes
+  int		length;		// attribute length
+  int		bits;		// bits a code
+  int		base;		// PACKFOR: value of code 0
+  const char*	values;		// values or codes of slots 1 to cnt
+  const char*	dict;		// PACKDICT: value of code c at
+  int		dictCnt;	//   dict + c * length, c < dictCnt
+  int		cnt;
+  const unsigned char* used;	// bit i: slot i + 1 is in use
+};
+
 // Class definition for a minirel data page.   
-// The design assumes that records are kept compacted when
-// deletions are performed. Notice, however, that the slot
-// array cannot be compacted.  Notice, this class does not keep
-// the records align, relying instead on upper levels to take
-// care of non-aligned attributes
 
 class Page {
 private:
@@ -41,16 +122,68 @@ private:
     short	slotCnt; // number of slots in use;
     short	freePtr; // offset of first free byte in data[]
     short	freeSpace; // number of bytes free in data[]
-    short	dummy;	// for alignment purposes
+    short	freeSlot; // version 2: first free slot, 0 if none
     int		nextPage; // forwards pointer
     int		curPage;  // page number of current pointer
 
+    // slot i, i <= 0: slot 0 is the member, the rest lie below it at
+    // the end of data[].  They are addressed from the page, not as
+    // slot[i], which the compiler may take to be slot[0] only.
+    slot_t* slotAt(const int i)
+      { return (slot_t*)((char*)this + offsetof(Page, slot)) + i; }
+    const slot_t* slotAt(const int i) const
+      { return (const slot_t*)((const char*)this + offsetof(Page, slot))
+	       + i; }
+
+    bool isV2() const
+      { return slotCnt < 0 && slot[0].length == -1
+	       && slot[0].offset == PAGEV2MAGIC; }
+    bool isPax() const  // plain or packed
+      { return slotCnt < 0 && slot[0].length == -1
+	       && (slot[0].offset == PAGEPAXMAGIC
+		   || slot[0].offset == PAGEPACKMAGIC); }
+    bool isPacked() const
+      { return slotCnt < 0 && slot[0].length == -1
+	       && slot[0].offset == PAGEPACKMAGIC; }
+    const Status insertV1(const Record & rec, RID& rid);
+    const Status deleteV1(const RID & rid);
+    const Status insertV2(const Record & rec, RID& rid);
+    const Status deleteV2(const RID & rid);
+    void compact();     // version 2: move the free space to the end
+
+    // PAX header, bitmap and minipages
+    short* paxHeader() { return (short*)data; }
+    const short* paxHeader() const { return (const short*)data; }
+    bool paxUsed(const int i) const;
+    const Status insertPax(const Record & rec, RID& rid);
+    const Status deletePax(const RID & rid);
+    const Status nextPax(const int i, RID& nextRid) const;
+    void setPaxFree();
+    int paxLen(const int a) const;     // length of attribute a
+    void readAttr(const int a, const int i, char* out) const;
+    const Status repack(const Record & rec);
+
 public:
-    void init(const int pageNo); // initialize a new page
+    // initialize a new page; older formats only so that tests can
+    // check they are still read
+    void init(const int pageNo, const int format = PAGEV2);
+    const int getFormat() const
+      { return isV2() ? PAGEV2 : isPacked() ? PAGEPACKED
+	       : isPax() ? PAGEPAX : PAGEV1; }
+
+    // initialize a new PAX page for records of attributes of these
+    // lengths, packed if attrPack (PACKNONE, PACKFOR or PACKDICT for
+    // each attribute) is given; paxCapacity is how many records it
+    // holds (packed pages: at least), 0 if not even one fits
+    void initPax(const int pageNo, const int attrCnt, const short attrLen[],
+		 const char attrPack[] = NULL);
+    static int paxCapacity(const int attrCnt, const short attrLen[],
+			   const bool packed = false);
     void dumpPage() const;       // dump contents of a page
 
     const Status getNextPage(int& pageNo) const; // returns value of nextPage
     const Status setNextPage(const int pageNo); // sets value of nextPage to pageNo
+    const Status setPageNo(const int pageNo);  // number of the page itself
     const short getFreeSpace() const; // returns amount of free space
 
     // inserts a new record (rec) into the page, returns RID of record 
@@ -68,7 +201,35 @@ public:
     const Status nextRecord (const RID & curRid, RID& nextRid) const;
 
     // returns reference to record with RID rid
-    const Status getRecord(const RID & rid, Record & rec);
+    // records of PAX pages are copied together into buf (MAXRECLEN
+    // bytes), which must then be given
+    const Status getRecord(const RID & rid, Record & rec, char* buf = NULL);
+
+    // copy length bytes at offset in the record with RID rid to out
+    const Status getField(const RID & rid, const int offset,
+                          const int length, char* out) const;
+
+    // PAX pages: the minipage of the attribute at offset in the
+    // record, values of free slots included; false if the page is
+    // not PAX or no attribute starts at offset
+    const bool getColumn(const int offset, PaxColumn& col) const;
+
+    // slotted pages: copy bytes [offset, offset + length) of every
+    // record long enough to out, one after the other, and its slot
+    // number to slotNos; returns how many were copied
+    const int gatherField(const int offset, const int length, char* out,
+			  int slotNos[]) const;
+
+    // code i of a packed minipage
+    static unsigned unpack(const char* codes, const int bits, const int i)
+    {
+	if (bits == 0) return 0;
+	unsigned long long word;
+	memcpy(&word, codes + (i * bits >> 3), sizeof word);
+	return (word >> (i * bits & 7)) & ((1u << bits) - 1);
+    }
 };
 
+static_assert(sizeof(Page) == PAGESIZE, "Page must fill exactly one page");
+
 #endif
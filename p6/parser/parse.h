@@ -57,8 +57,13 @@ typedef enum {
     N_LOAD,
     N_PRINT,
     N_HELP,
+    N_STATS,
+    N_VACUUM,
     N_SELECT,
     N_JOIN,
+    N_AND,
+    N_OR,
+    N_NOT,
     N_PRIMATTR,
     N_QUALATTR,
     N_ATTRVAL,
@@ -100,6 +105,7 @@ typedef struct node {
 	struct {
 	    char *relname;
 	    struct node *attrlist;
+	    int layout;
 	    struct node *primattr;
 	} CREATE;
 
@@ -137,6 +143,16 @@ typedef struct node {
 	    char *relname;
 	} HELP;
 
+	// stats node */
+	struct {
+	    char *option;
+	} STATS;
+
+	// vacuum node */
+	struct {
+	    char *relname;
+	} VACUUM;
+
 	// select node */
 	struct {
 	    struct node *selattr;
@@ -151,6 +167,12 @@ typedef struct node {
 	    struct node *joinattr2;
 	} JOIN;
 
+	// and, or, not node (right is NULL for not) */
+	struct {
+	    struct node *left;
+	    struct node *right;
+	} BOOL;
+
 	// qualified attribute node */
 	struct {
 	    char *relname;
@@ -215,7 +237,8 @@ NODE *newnode(int kind);
 NODE *query_node(char *relname, NODE *attrlist, NODE *n);
 NODE *insert_node(char *relname, NODE *attrlist);
 NODE *delete_node(char *relname, NODE *qual);
-NODE *create_node(char *relname, NODE *attrlist, NODE *primattr);
+NODE *create_node(char *relname, NODE *attrlist, int layout,
+		  NODE *primattr);
 NODE *destroy_node(char *relname);
 NODE *build_node(char *relname, char *attrname, int nbuckets);
 NODE *rebuild_node(char *relname, char *attrname, int nbuckets);
@@ -223,8 +246,11 @@ NODE *drop_node(char *relname, char *attrname);
 NODE *load_node(char *relname, char *filename);
 NODE *print_node(char *relname);
 NODE *help_node(char *relname);
+NODE *stats_node(char *option);
+NODE *vacuum_node(char *relname);
 NODE *select_node(NODE *selattr, int op, NODE *value);
 NODE *join_node(NODE *joinattr1, int op, NODE *joinattr2);
+NODE *bool_node(int kind, NODE *left, NODE *right);
 NODE *qualattr_node(char *relname, char *attrname);
 NODE *primattr_node(char *attrname, int nbuckets);
 NODE *attrval_node(char *attrname, NODE *value);
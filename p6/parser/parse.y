@@ -5,7 +5,8 @@
 
 #include <stdlib.h>
 #include <stdio.h>
-#include "heapfile.h"
+#include "catalog.h"
+#include "wal.h"
 #include "parse.h"
 
 extern "C" int isatty(int);
@@ -13,6 +14,7 @@ extern int yylex();
 extern int yywrap();
 extern void reset_scanner();
 extern void quit();
+extern Error error;
 
 void yyerror(char *);
 
@@ -51,6 +53,10 @@ static NODE *parse_tree;                // root of parse tree
 		RW_OR
 		RW_NOT
 		RW_VALUES	
+		RW_STATS
+		RW_VACUUM
+		RW_PAX
+		RW_COMPRESSED
 		INT_TYPE
 		REAL_TYPE
 		CHAR_TYPE	
@@ -64,6 +70,10 @@ static NODE *parse_tree;                // root of parse tree
 		T_EOF
     		NOTOKEN
 
+%left	RW_OR
+%left	RW_AND
+%right	RW_NOT
+
 %token	<ival>	T_INT
 
 %token	<rval>	T_REAL
@@ -73,6 +83,7 @@ static NODE *parse_tree;                // root of parse tree
 		T_SHELL_CMD
 
 %type	<ival>	op
+		opt_layout
 
 %type	<sval>	opt_into_relname
 		opt_relname
@@ -92,10 +103,13 @@ static NODE *parse_tree;                // root of parse tree
 		load
 		print
 		help
+		stats
+		vacuum
 		quit
 		opt_primary_attr
 		opt_where
 		qual
+		condition
 		selection
 		join
 		non_mt_qualattr_list
@@ -155,6 +169,8 @@ command
 	| load
 	| print
 	| help
+	| stats
+	| vacuum
 	| quit
 	| nothing
 	{
@@ -256,9 +272,10 @@ delete
 	;
 
 create
-	: RW_CREATE RW_TABLE string '(' non_mt_attrtype_list ')' opt_primary_attr
+	: RW_CREATE RW_TABLE string '(' non_mt_attrtype_list ')' opt_layout
+	  opt_primary_attr
 	{
-		$$ = create_node($3, $5, $7);
+		$$ = create_node($3, $5, $7, $8);
 	}
 	;
 
@@ -316,6 +333,24 @@ help
 	}
 	;
 
+stats
+	: RW_STATS
+	{
+		$$ = stats_node(NULL);
+	}
+	| RW_STATS string
+	{
+		$$ = stats_node($2);
+	}
+	;
+
+vacuum
+	: RW_VACUUM string
+	{
+		$$ = vacuum_node($2);
+	}
+	;
+
 quit
 	: RW_QUIT ';'
 	{
@@ -323,6 +358,21 @@ quit
 	}
 	;
 
+opt_layout
+	: RW_PAX
+	{
+		$$ = PAXLAYOUT;
+	}
+	| RW_COMPRESSED
+	{
+		$$ = PACKEDLAYOUT;
+	}
+	| nothing
+	{
+		$$ = ROWLAYOUT;
+	}
+	;
+
 opt_primary_attr
 	: RW_PRIMARY string RW_NUMBUCKETS T_EQ T_INT
 	{
@@ -368,10 +418,30 @@ opt_where
 	;
 
 qual
-	: selection
+	: condition
 	| join
 	;
 
+condition
+	: condition RW_OR condition
+	{
+		$$ = bool_node(N_OR, $1, $3);
+	}
+	| condition RW_AND condition
+	{
+		$$ = bool_node(N_AND, $1, $3);
+	}
+	| RW_NOT condition
+	{
+		$$ = bool_node(N_NOT, $2, NULL);
+	}
+	| '(' condition ')'
+	{
+		$$ = $2;
+	}
+	| selection
+	;
+
 selection
 	: qualattr op value
 	{
@@ -518,7 +588,7 @@ nothing
 void parse(void)
 {
   extern void new_query();
-  extern void interp(NODE *);
+  extern bool interp(NODE *);
 
   for(;;){
 
@@ -529,9 +599,17 @@ void parse(void)
     printf("%s", PROMPT);
     fflush(stdout);
 
-    // if a query was successfully read, interpret it
-    if(yyparse() == 0 && parse_tree != NULL)
-      interp(parse_tree);
+    // if a query was successfully read, interpret it.  Every
+    // statement is a transaction of its own, rolled back if it
+    // fails.
+    if(yyparse() == 0 && parse_tree != NULL) {
+      bool ok = interp(parse_tree);
+      if (logMgr) {
+        Status status = ok ? logMgr->commit() : logMgr->abort();
+        if (status != OK)
+          error.print(status);
+      }
+    }
   }
 }
 
@@ -5,6 +5,17 @@
 
 enum JoinType {NLJoin, SMJoin, HashJoin};
 
+// The where clause of a selection: attr op attr.attrValue, or the AND
+// or the OR of two clauses, or the NOT of one (left).  Values are in
+// string form, as in attrInfo.
+typedef struct condInfo {
+  PredKind kind;
+  attrInfo attr;
+  Operator op;
+  struct condInfo *left;
+  struct condInfo *right;
+} condInfo;
+
 //
 // Prototypes for query layer functions
 //
@@ -17,6 +28,11 @@ const Status QU_Select(const string & result,
 		       const Operator op, 
 		       const char *attrValue);
 
+const Status QU_Select(const string & result, 
+		       const int projCnt, 
+		       const attrInfo projNames[],
+		       const condInfo *cond);
+
 const Status QU_Join(const string & result, 
 		     const int projCnt, 
 		     const attrInfo projNames[],
@@ -0,0 +1,236 @@
+#ifndef REPL_H
+#define REPL_H
+
+#include <atomic>
+#include <mutex>
+#include <list>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+// Buffer replacement policies.  BufMgr tells the policy about every
+// page it loads (admit), every hit (reference) and every page that
+// leaves the pool other than by replacement (drop).  When it needs a
+// frame it asks for a victim: free frames first, otherwise the
+// resident page the policy would evict, skipping pinned frames.
+//
+// A victim is only a candidate.  BufMgr still has to latch and claim
+// the frame; if that fails (the page got pinned, another thread is
+// doing I/O on it) the frame is handed back with restore().  If it
+// succeeds the next call for the frame is admit() with the new page,
+// or drop() if the frame ends up unused.
+//
+// Pages are identified by a 64-bit key, (file id << 32) | pageNo,
+// so that policies can remember pages that are no longer resident.
+
+class BufDesc;
+
+class ReplPolicy {
+ public:
+  ReplPolicy(BufDesc* bufTable, int numBufs);
+  virtual ~ReplPolicy() {}
+
+  virtual const char* name() const = 0;
+
+  virtual void reference(int frame) = 0;           // page in frame was hit
+  virtual void admit(int frame, long long key) = 0; // frame now holds key
+  virtual void drop(int frame) = 0;                // frame is free again
+  // candidate frame, -1 if all pinned; steps is set to the number
+  // of frames the policy looked at to find it
+  virtual int  victim(int & steps) = 0;
+  virtual void restore(int frame) = 0;             // candidate not taken
+
+  // up to max frames that are likely to be victims soon, most
+  // likely first.  Only a hint for the background writer: the
+  // frames may be pinned, free or already replaced.
+  virtual int  upcoming(int* frames, int max) = 0;
+
+  // policy by name ("clock", "lru2", "2q", "arc"); NULL if unknown
+  static ReplPolicy* create(const char* name, BufDesc* bufTable, int numBufs);
+  static bool known(const char* name);
+  static const char* names();
+
+ protected:
+  bool pinned(int frame) const;
+
+  BufDesc* bufTable;
+  int numBufs;
+};
+
+
+// The original single reference bit clock.  Lock free: threads
+// advance the hand with fetch_add and clear reference bits as they
+// pass.
+
+class ClockPolicy : public ReplPolicy {
+ public:
+  ClockPolicy(BufDesc* bufTable, int numBufs);
+  ~ClockPolicy();
+
+  const char* name() const { return "clock"; }
+  void reference(int frame) { refbit[frame] = true; }
+  void admit(int frame, long long key) { refbit[frame] = true; }
+  void drop(int frame) { refbit[frame] = false; }
+  int  victim(int & steps);
+  void restore(int frame) {}
+  int  upcoming(int* frames, int max);
+
+ private:
+  std::atomic<unsigned int> clockHand;
+  std::atomic<bool>* refbit;
+};
+
+
+// Non-resident pages remembered by key, oldest first.  Used for the
+// ghost lists of 2Q and ARC.
+
+class GhostList {
+ public:
+  bool contains(long long key) const { return pos.count(key) != 0; }
+  int  size() const { return (int)fifo.size(); }
+  void push(long long key);
+  bool erase(long long key);
+  long long oldest() const { return fifo.back(); }
+  void popOldest();
+
+ private:
+  std::list<long long> fifo;    // newest at the front
+  std::unordered_map<long long, std::list<long long>::iterator> pos;
+};
+
+
+// Base for policies that keep frames on LRU lists.  The lists are
+// protected by one mutex.  Every frame is on exactly one list, on the
+// free list, or in transit between victim() and admit/restore/drop.
+//
+// Hits do not take the mutex.  Like the clock's reference bits, a hit
+// only sets a bit for the frame; the first hit after the bit was
+// cleared also pushes the frame on a lock-free stack.  The hits on
+// the stack are applied to the lists, in the order the bits were set,
+// the next time the mutex is taken for a miss, so a frame hit many
+// times in between counts as hit once.
+
+class ListPolicy : public ReplPolicy {
+ public:
+  ListPolicy(BufDesc* bufTable, int numBufs, int numLists);
+  ~ListPolicy();
+
+  void reference(int frame);
+  void admit(int frame, long long key);
+  void drop(int frame);
+  int  victim(int & steps);
+  void restore(int frame);
+  int  upcoming(int* frames, int max);
+
+ protected:
+  enum { FREE = -1, TRANSIT = -2 };
+
+  struct FrameList {
+    int head, tail;             // most recently used at head
+    int size;
+  };
+
+  // policy specific parts, called with the mutex held
+  virtual void hit(int frame) = 0;      // frame is on list where[frame]
+  virtual void evicted(int frame, int list) = 0;  // keys[frame] left list
+  virtual void loaded(int frame) = 0;   // keys[frame] is new, put it on a list
+  virtual int  choose() = 0;            // unpinned frame to evict, or -1
+  virtual void forget(int frame) {}     // page left without replacement
+
+  void pushFront(int list, int frame);
+  void unlink(int frame);
+  int  lruUnpinned(int list);           // least recent unpinned frame
+  void applyHits();                     // hits recorded since last call
+
+  std::mutex mutex;
+  std::atomic<bool>* hitbit;    // frame was hit since the last applyHits
+  std::atomic<int> hitHead;     // stack of hit frames, -1 if empty
+  int* hitNext;                 // next frame on the stack
+  int* hitOrder;                // scratch for applyHits
+  int numLists;         // lists are drained in order on eviction
+  FrameList* lists;
+  int* next;
+  int* prev;
+  int* where;           // list of each frame, FREE or TRANSIT
+  int* from;            // list a frame in transit came from
+  long long* keys;      // page held by each frame
+  int* freeFrames;      // stack of free frames
+  int numFree;
+  int looked;           // frames choose() has looked at
+};
+
+
+// LRU-2 (O'Neil, O'Neil and Weikum): evict the page whose second
+// most recent reference is oldest; pages seen only once go first.
+// Reference history is kept for recently evicted pages too.
+
+class LRUKPolicy : public ListPolicy {
+ public:
+  LRUKPolicy(BufDesc* bufTable, int numBufs);
+  ~LRUKPolicy();
+  const char* name() const { return "lru2"; }
+  int  upcoming(int* frames, int max);
+
+ protected:
+  void hit(int frame);
+  void evicted(int frame, int list);
+  void loaded(int frame);
+  int  choose();
+  void forget(int frame);
+
+ private:
+  typedef std::tuple<long, long, int> histKey;  // (ref 2, ref 1, frame)
+
+  long clock;           // logical time, one tick per reference
+  long* last;           // most recent reference of each frame
+  long* prior;          // the one before, 0 if none
+  std::set<histKey> order;
+  GhostList retained;   // evicted pages whose history we keep
+  std::unordered_map<long long, std::pair<long, long> > history;
+};
+
+
+// 2Q (Johnson and Shasha), full version: new pages enter the A1in
+// FIFO; pages evicted from it are remembered in A1out and go to the
+// Am LRU list if they are requested again.
+
+class TwoQPolicy : public ListPolicy {
+ public:
+  TwoQPolicy(BufDesc* bufTable, int numBufs);
+  const char* name() const { return "2q"; }
+
+ protected:
+  void hit(int frame);
+  void evicted(int frame, int list);
+  void loaded(int frame);
+  int  choose();
+
+ private:
+  enum { A1IN = 0, AM = 1 };
+  int kin;              // target size of A1in
+  int kout;             // size of A1out
+  GhostList a1out;
+};
+
+
+// ARC (Megiddo and Modha): T1 holds pages seen once, T2 pages seen
+// at least twice; ghost lists B1/B2 steer the target size p of T1.
+
+class ARCPolicy : public ListPolicy {
+ public:
+  ARCPolicy(BufDesc* bufTable, int numBufs);
+  const char* name() const { return "arc"; }
+
+ protected:
+  void hit(int frame);
+  void evicted(int frame, int list);
+  void loaded(int frame);
+  int  choose();
+
+ private:
+  enum { T1 = 0, T2 = 1 };
+  int p;                // target size of T1
+  GhostList b1, b2;
+};
+
+#endif
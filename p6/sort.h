@@ -54,6 +54,7 @@ class SortedFile {
   Datatype type;                        // type of sort attribute
   int offset;                           // offset of sort attribute
   int length;                           // length of sort attribute
+  int (*cmp)(const char*, const char*, int, int); // compares two of them
 
   SORTREC* buffer;                      // in-memory sort buffer
   int maxItems;                         // max. # of items/tuples in buffer
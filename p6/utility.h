@@ -27,6 +27,13 @@ const Status UT_Load(const string & relation,
 
 const Status UT_Print(string relation);
 
+// buffer pool statistics: option "" prints them, "reset" clears
+// them, "json" dumps them as one line of JSON
+const Status UT_Stats(const string & option);
+
+// moves the records of a relation into as few pages as possible
+const Status UT_Vacuum(const string & relation);
+
 void   UT_Quit(void);
 
 #endif
@@ -0,0 +1,212 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <set>
+#include <string>
+#include <vector>
+#include "page.h"
+#include "db.h"
+
+// Write-ahead log.  With a log the buffer pool is no-force and steal:
+// closing a file leaves its dirty pages in the pool (DB::closeFile
+// keeps the file open), and a dirty page may be written out before
+// the statement that changed it commits, as long as the log records
+// describing the change are on disk first (BufMgr checks the LSN of
+// a frame before writing it).
+//
+// Every statement is a transaction; it begins with the first record
+// it logs and ends with commit(), or abort() if it failed.  What is
+// logged:
+//
+//   - inserts and deletes of records (redo and undo)
+//   - images of pages filled elsewhere and appended whole (redo, and
+//     undo by deleting the records of the page)
+//   - a full image of a page the first time it changes after a
+//     checkpoint, so that redo starts from a known page state and
+//     torn page writes are repaired
+//   - page initialization and changes to the page chain, images of
+//     heap file header pages and the header of the DB file when
+//     pages are allocated or disposed of.  These are redo only:
+//     structure is never rolled back.
+//
+// Free space map entries are logged as one byte images, so that the
+// map never points at a page that has been freed.
+//
+// A checkpoint writes all dirty pages and file headers, syncs the
+// files and empties the log.  Recovery at startup repeats history
+// from the start of the log, then rolls back the statements that
+// did not commit, logging compensation records so that a crash
+// during recovery does no harm.
+//
+// LSNs are byte positions in the log, counted from when it was
+// created; the LSN of a record is the position just past its end.
+
+const int LOGNAMESIZE = 64;     // longest file name in a record, with 0
+
+enum LogType {
+  LOG_CHECKPOINT,       // first record of the log
+  LOG_IMAGE,            // bytes [slot, slot + dataLen) of a page
+  LOG_INIT,             // page initialized, next page is slot
+  LOG_LINK,             // next page of page set to slot
+  LOG_INSERT,           // record inserted into slot
+  LOG_DELETE,           // record deleted from slot
+  LOG_FILEHDR,          // header of the DB file (a DBPage)
+  LOG_DESTROY,          // file destroyed
+  LOG_COMMIT,           // transaction committed
+  LOG_END,              // transaction rolled back
+  LOG_APPEND            // image of a page appended whole
+};
+
+struct LogRec
+{
+  int       length;     // of the whole record, data included
+  int       type;       // LogType
+  int       txn;        // 0 for records outside transactions
+  int       pageNo;
+  int       slot;       // slot, image offset or next page
+  int       dataLen;    // bytes of data following the record
+  long long lsn;        // of this record
+  long long prevLSN;    // previous record of the transaction, 0 if none
+  long long undoNext;   // compensation records: next record to undo;
+                        // -1 for other records
+  unsigned int sum;     // checksum of the record and its data
+  char      fileName[LOGNAMESIZE];
+};
+
+
+struct LogStats
+{
+  std::atomic<long> records;    // records appended
+  std::atomic<long> bytes;      // bytes appended
+  std::atomic<long> images;     // full page images among them
+  std::atomic<long> commits;    // transactions committed
+  std::atomic<long> aborts;     // ... and rolled back
+  std::atomic<long> syncs;      // fdatasync calls on the log
+  std::atomic<long> checkpoints;
+
+  void clear()
+    {
+      records = bytes = images = commits = aborts = syncs = checkpoints = 0;
+    }
+  LogStats() { clear(); }
+};
+
+
+class LogMgr
+{
+public:
+  // opens (or creates) the log file; run recover() before anything
+  // else uses the database
+  LogMgr(const string & logName, Status & status);
+  ~LogMgr();
+
+  // Page changes.  Each is logged for the calling thread's
+  // transaction and the LSN is noted on the frame of the page.
+  // touch() logs an image of the first len bytes of the page unless
+  // the page was logged since the last checkpoint; call it before
+  // changing the page.
+  void touch(File* file, const int pageNo, const Page* page,
+             const int len = PAGESIZE);
+  void logImage(File* file, const int pageNo, const Page* page,
+                const int offset, const int len);
+  void logAppend(File* file, const int pageNo, const Page* page);
+  void logInit(File* file, const int pageNo, const Page* page,
+               const int nextPage);
+  void logLink(File* file, const int pageNo, const Page* page,
+               const int nextPage);
+  void logInsert(File* file, const int pageNo, const Page* page,
+                 const RID & rid, const Record & rec);
+  void logDelete(File* file, const int pageNo, const Page* page,
+                 const RID & rid, const Record & rec);
+  void logFileHeader(File* file);
+
+  // the file is about to be destroyed; the record is on disk when
+  // this returns, so that a file created later under the same name
+  // never gets the old file's changes
+  const Status logDestroy(const string & fileName);
+
+  // commit the calling thread's transaction, if it logged anything
+  const Status commit();
+
+  // roll it back instead: its inserts and deletes are undone as
+  // recovery undoes those of a transaction that did not commit
+  const Status abort();
+
+  // make the log durable up to lsn (all of it for -1)
+  const Status flush(const long long lsn = -1);
+
+  // write out everything and empty the log.  Skipped while any
+  // transaction is running.
+  const Status checkpoint();
+
+  // bring the database back to its state after the last commit
+  const Status recover();
+
+  // 0: commit waits until its record is on disk; commits running at
+  // the same time share one sync.  Otherwise commit returns at once
+  // and the log is synced every usec microseconds, so statements
+  // committed within that window share one sync; a crash loses at
+  // most the last window of commits.
+  void setGroupCommit(const int usec);
+  int  getGroupCommit() const { return groupUsec; }
+
+  // checkpoint once the log has grown this big
+  void setCheckpointBytes(const long bytes) { checkpointBytes = bytes; }
+
+  const LogStats & getStats() const { return stats; }
+  void clearStats() { stats.clear(); }
+  void printStats();
+
+private:
+  string name;
+  int fd;
+
+  std::mutex latch;             // protects everything below
+  std::condition_variable synced;
+  std::vector<char> pending;    // appended, not yet written
+  long long base;               // LSN of the start of the log file
+  long long tail;               // LSN of the end of the log
+  long long durable;            // log is on disk up to here
+  bool flushing;                // a thread is writing the log
+  int nextTxn;
+  int active;                   // transactions that logged something
+  std::set<std::pair<std::string, int> > logged;  // pages imaged
+                                                  // since the checkpoint
+  LogStats stats;
+  long checkpointBytes;
+
+  int groupUsec;
+  std::thread syncer;           // syncs the log for group commit
+  std::condition_variable syncerWake;
+  bool syncerStop;
+  void syncerThread();
+
+  // the calling thread's transaction; 0 if none
+  static thread_local int curTxn;
+  static thread_local long long lastLSN;
+
+  // append to the calling thread's transaction, or as is with the
+  // latch held; both return the LSN of the record
+  long long append(LogRec & rec, const void* data);
+  long long appendLocked(LogRec & rec, const void* data);
+  void fill(LogRec & rec, const int type, File* file, const int pageNo,
+            const int slot);
+  void noteLSN(const Page* page, const long long lsn);
+  const Status resetLog();      // empty the log file; latch held
+
+  // recovery
+  const Status redo(const LogRec & rec, const char* data);
+  const Status undo(const LogRec & rec, const char* data);
+  const Status undoAppend(File* file, const LogRec & rec, Page* page,
+                          int & delta);
+  const Status openForRecovery(const string & fileName, File* & file);
+  std::vector<std::pair<std::string, File*> > recoveryFiles;
+};
+
+extern LogMgr* logMgr;          // NULL: no log, files are forced on close
+
+#endif